@@ -0,0 +1,146 @@
+'''
+    Checks fireServe (python/FiRE/fireServe, built by ./INSTALL --serve).
+
+    Usage (from FiRE directory):
+        python example/fireServe_check.py
+
+    Model is fitted on first 1480 cells of preprocessed jurkat data, remaining 100 cells are held out.
+        1. Scores from --fit equal scores from --model after --save.
+        2. Held out cells get finite scores.
+        3. Malformed requests get ERROR responses, and STATS follows earlier requests.
+        4. If FiRE python module is installed, FiRE.save can be served and matches FiRE.score exactly,
+           and a model restored by FiRE.load scores the same as the fitted one.
+    Exits with non-zero status on failure.
+'''
+
+import sys
+sys.path.append('python/FiRE')
+
+import gzip
+import math
+import os
+import shutil
+import struct
+import subprocess
+import tempfile
+
+SERVE = 'python/FiRE/fireServe'
+DATA = 'data/preprocessedData_jurkat_two_species_1580.txt.gz'
+FAILURES = []
+
+
+def check(condition, message):
+    print('{} : {}'.format('PASS' if condition else 'FAIL', message))
+    if not condition:
+        FAILURES.append(message)
+
+
+def serve(args, requests):
+    proc = subprocess.Popen([SERVE] + args, stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    out, err = proc.communicate(requests.encode())
+    if proc.returncode != 0:
+        sys.stderr.write(err.decode())
+    check(proc.returncode == 0, 'fireServe {} exits with status 0'.format(' '.join(args)))
+    return out.decode().splitlines()
+
+
+def finite(value):
+    return not (math.isinf(value) or math.isnan(value))
+
+
+def float32(value):
+    #Served scores are printed with enough digits to identify the float returned by cppFiRE::score
+    return struct.unpack('f', struct.pack('f', value))[0]
+
+
+def request(name, rows):
+    return '{} {}\n{}\n'.format(name, len(rows), '\n'.join(rows))
+
+
+def parse(lines):
+    #Responses as {id : [scores]} or {id : 'ERROR ...'}
+    responses = {}
+    i = 0
+    while i < len(lines):
+        head = lines[i].split(' ', 1)
+        if head[0] == 'STATS' or head[1].startswith('ERROR'):
+            responses[head[0]] = head[1]
+            i += 1
+        else:
+            n = int(head[1])
+            responses[head[0]] = [float(x) for x in lines[i + 1:i + 1 + n]]
+            i += 1 + n
+    return responses
+
+
+if not os.path.exists(SERVE):
+    sys.exit('{} not found, build it with ./INSTALL --serve'.format(SERVE))
+
+fid = gzip.open(DATA, 'rb')
+rows = [line.decode().strip() for line in fid if line.strip()]
+fid.close()
+reference, heldOut = rows[:1480], rows[1480:]
+heldOutX = [[float(x) for x in row.split()] for row in heldOut]
+
+workDir = tempfile.mkdtemp()
+try:
+    refFile = os.path.join(workDir, 'reference.txt')
+    modelFile = os.path.join(workDir, 'model.bin')
+    with open(refFile, 'w') as fid:
+        fid.write('\n'.join(reference) + '\n')
+
+    #1, 2. Fit vs saved model, held out cells
+    requests = request('train', reference[:200]) + request('held', heldOut)
+    fitted = serve(['--fit', refFile, '--save', modelFile], requests)
+    loaded = serve(['--model', modelFile], requests)
+    check(fitted == loaded, 'scores from --fit equal scores from --model')
+
+    scores = parse(loaded)
+    check(len(scores.get('held', [])) == len(heldOut), 'all held out cells scored')
+    check(all(finite(s) for s in scores.get('held', [])), 'held out cells get finite scores')
+
+    #3. Malformed requests, STATS ordering
+    requests = (request('ok', heldOut[:3]) +
+                'short 1\n1 2 3\n' +
+                'noCount\n' +
+                'STATS\n' +
+                'huge 99999999999\n')                                        #Its rows are skipped till end of input, hence last
+    responses = parse(serve(['--model', modelFile, '--max-request', '1000'], requests))
+    check(isinstance(responses.get('ok'), list) and len(responses['ok']) == 3, 'valid request scored')
+    for name in ['short', 'noCount', 'huge']:
+        check(str(responses.get(name, '')).startswith('ERROR'), 'malformed request "{}" gets ERROR'.format(name))
+    check(responses.get('STATS', '').startswith('count=1 '), 'STATS counts request sent before it')
+
+    #4. Python module
+    try:
+        import FiRE
+    except ImportError:
+        FiRE = None
+        print('SKIP : FiRE python module not installed (./INSTALL --inplace --py)')
+
+    if FiRE is not None:
+        model = FiRE.FiRE(L=100, M=50)
+        model.fit([[float(x) for x in row.split()] for row in reference])
+        model.pseudoCount = 1
+        pyScores = model.score(heldOutX)
+        pyModelFile = os.path.join(workDir, 'pyModel.bin')
+        model.save(pyModelFile)
+        served = parse(serve(['--model', pyModelFile], request('held', heldOut))).get('held', [])
+        check([float32(s) for s in served] == pyScores, 'FiRE.save served by fireServe matches FiRE.score exactly')
+
+        restored = FiRE.FiRE(L=1, M=1)
+        restored.load(pyModelFile)
+        restored.pseudoCount = 1
+        check(restored.L == 100 and restored.M == 50, 'FiRE.load restores parameters')
+        check(restored.score(heldOutX) == pyScores, 'FiRE.load followed by FiRE.score reproduces scores of fitted model')
+        try:
+            restored.bins
+            check(False, 'FiRE.bins raises after FiRE.load')
+        except ValueError:
+            check(True, 'FiRE.bins raises after FiRE.load')
+finally:
+    shutil.rmtree(workDir)
+
+if FAILURES:
+    sys.exit('{} check(s) failed'.format(len(FAILURES)))
+print('All checks passed')
@@ -24,6 +24,8 @@
 
 #Import all required libs here.
 from libcpp.vector cimport vector
+from libcpp.string cimport string
+from libcpp cimport bool
 
 #All typedef declerations here
 ctypedef unsigned int uint32_t
@@ -38,15 +40,19 @@ cdef extern from "cppFiRE.h":
         size_t H                                                #Number of bins
         size_t seed                                             #Seed for random number generator
         int verbose                                             #Controls verbosity of program (0/1)
+        float pseudoCount                                       #Pseudo-count added to bin occupancy while scoring (0 - unsmoothed)
         vector[vector[uint32_t]] dims                           #Container for randomly generated M feature index for each estimator
         vector[vector[float]] thresholds                        #Container for randomly generated M threshold
                                                                 #corresponding to randomly generated M feature indexes for each estimator
         vector[vector[uint32_t]] weights                        #Containder for randomly generated M weights
                                                                 #corresponding to randomly generated M feature indexes for each estimator
         vector[vector[vector[uint32_t]]] bins                   #Containder for hash table for each estimator
+        vector[vector[uint32_t]] counts                         #Container for bin occupancy of hash table for each estimator
 
         #Class methods
         cppFiRE(int, int, size_t, size_t, int) except +         #Class constructor
         void fit(vector[vector[float]]&)                        #Public method to fit data - This method call for random table
                                                                 #generation and hash table generation
         vector[float] score(vector[vector[float]]&)             #Public method to compute score
+        bool save(const string&) except +                       #Public method to write fitted model to a binary file
+        bool load(const string&) except +                       #Public method to read fitted model from a binary file
@@ -26,6 +26,7 @@
         model = FiRE.FiRE(L=100, M=50, H=1017881, seed=5489, verbose=0)
         model.fit(data)
         scores = model.score(data)
+        model.save('model.bin')     #Fitted model can be served by fireServe (./INSTALL --serve)
 '''
 
 #
@@ -72,6 +73,31 @@ cdef class FiRE:
         '''
         return self.fire.score(X)
 
+    def save(self, path):                                                                       #Method for writing fitted model to file
+        '''
+            Signature:
+                FiRE.save(path)
+
+            Input:
+                path : [required] : str : Output file, can be loaded by FiRE.load or fireServe --model
+        '''
+        if self.fire.counts.size() == 0:
+            raise ValueError('Model is not fitted')
+        if not self.fire.save(path.encode()):
+            raise IOError('Could not save model to {}'.format(path))
+
+    def load(self, path):                                                                       #Method for reading fitted model from file
+        '''
+            Signature:
+                FiRE.load(path)
+
+            Input:
+                path : [required] : str : File written by FiRE.save. L, M, H and seed are replaced by stored values.
+                                          Model is left unchanged if loading fails.
+        '''
+        if not self.fire.load(path.encode()):
+            raise IOError('Could not load model from {}'.format(path))
+
     def __repr__(self):                                                                         #Inter function to pretty print the class object
         return '<FiRE(L={}, M={}, H={}, seed={}, verbose={})>'.format(self.fire.L, self.fire.M, self.fire.H, self.fire.seed, self.fire.verbose)
 
@@ -115,12 +141,27 @@ cdef class FiRE:
         '''
         return self.fire.verbose
 
+    @property
+    def pseudoCount(self):
+        '''
+            float : scalar : Pseudo-count added to bin occupancy while scoring.
+                           : 0 (default) gives infinite score to samples falling in an empty bin, use e.g. 1 to score held out samples.
+        '''
+        return self.fire.pseudoCount
+
+    @pseudoCount.setter
+    def pseudoCount(self, float value):
+        self.fire.pseudoCount = value
+
     @property
     def bins(self):
         '''
             unsigned int : [L x H x -1] : Hash table across estimators
                                         : -1 represents dynamic size of dimension
+                                        : Not available for a model restored by FiRE.load (only bin occupancy is saved)
         '''
+        if self.fire.bins.size() == 0 and self.fire.counts.size() > 0:
+            raise ValueError('bins (sample indices) are not saved, they are unavailable after FiRE.load')
         return self.fire.bins
 
     @property
@@ -29,6 +29,7 @@
 #include <boost/random.hpp>                             //Required for random number generator (mersenne_twister). Needs boost library.
 #include <cfloat>                                       //Required for FLT_MAX macro.
 #include <cmath>                                        //Required for log function.
+#include <fstream>                                      //Required for saving and loading fitted model.
 
 //Random Number generator setup
 typedef boost::mt19937 Rng;                             //mersenne_twister random number generator
@@ -58,6 +59,11 @@ cppFiRE::cppFiRE(int L, int M, unsigned int H=1017881, unsigned int seed=5489u,
     this->H = H;
     this->seed = seed;
     this->verbose = verbose;
+    this->pseudoCount = 0;
+    this->size_ = 0;
+    this->dim = 0;
+    this->min_ = 0;
+    this->max_ = 0;
 }
 
 
@@ -121,9 +127,10 @@ void cppFiRE::__getTables(){
  * Input -                                                                                                                                          *
  * None                                                                                                                                             *
  *              This function creates the hash table for each estimator.                                                                            *
- *              This function sets up one class variable.                                                                                           *
+ *              This function sets up two class variables.                                                                                          *
  *                  bins :  [L, H, -1] : unsigned int 3D vector : This container stors the hash table for each estimator.                           *
  *                                     : -1 signifies that number of element in the dimension is dynamic.                                           *
+ *                  counts : [L, H]    : unsigned int 2D vector : This container stores number of samples in each bin of bins, used by score.       *
  *                                                                                                                                                  *
  * Returns -                                                                                                                                        *
  * void                                                                                                                                             *
@@ -155,6 +162,13 @@ void cppFiRE::__getBins(std::vector< std::vector<float> >& X){
         }
     }
 
+    this->counts.resize(this->L);
+    for(i=0; i<this->L; i++){
+        this->counts[i].resize(this->H);
+        for(index=0; index<this->H; index++)
+            this->counts[i][index] = this->bins[i][index].size();
+    }
+
 }
 
 
@@ -218,6 +232,8 @@ void cppFiRE::fit(std::vector< std::vector<float> >& X){
  * X        [required], float, [samples x features],    Dataset                                                                                     *
  *                                                                                                                                                  *
  *              This function computes the FiRE score based on the hash table.                                                                      *
+ *              Bin occupancy c of each estimator contributes log((c + pseudoCount) / (samples + pseudoCount)). With pseudoCount 0 (default), a     *
+ *              sample falling in an empty bin of any estimator gets infinite score, hence new (held out) samples need pseudoCount > 0.             *
  *                                                                                                                                                  *
  * Returns -                                                                                                                                        *
  * scores :         float, [samples],       Calculated Score.                                                                                       *
@@ -233,8 +249,8 @@ void cppFiRE::fit(std::vector< std::vector<float> >& X){
     int i, j, k;
     float _t, lf;
 
-    _scores.resize(this->size_);
-    for(j=0; j<this->size_; j++){                                       //revisiting steps for index calculation
+    _scores.resize(X.size());
+    for(j=0; j<(int)X.size(); j++){                                       //revisiting steps for index calculation
         lf = 0;
         for(i=0; i<this->L; i++){
             index = 0;
@@ -246,9 +262,195 @@ void cppFiRE::fit(std::vector< std::vector<float> >& X){
                 index += (_p * _a);
             }
             index = index % this->H;                                    //Getting bin index of hash table
-            lf += log((this->bins[i][index].size()*1.0)/this->size_);   //Gathering neighborhood information
+            lf += log((this->counts[i][index] + (double)this->pseudoCount)/(this->size_ + (double)this->pseudoCount));   //Gathering neighborhood information
         }
         _scores[j] = -2 * lf;                                           //Computing scores
     }
     return _scores;
 }
+
+
+//Fitted model file setup
+static const char MODEL_MAGIC[4] = {'F', 'i', 'R', 'E'};  //File signature of fitted model
+static const uint32_t MODEL_VERSION = 1;                    //File format version of fitted model
+
+template <typename T> static void __write(std::ofstream& out, const T& value){
+    out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T> static void __read(std::ifstream& in, T& value){
+    in.read(reinterpret_cast<char *>(&value), sizeof(T));
+}
+
+template <typename T> static void __writeTable(std::ofstream& out, const std::vector< std::vector<T> >& table){
+    size_t i;
+    for(i=0; i<table.size(); i++)
+        out.write(reinterpret_cast<const char *>(&table[i][0]), table[i].size() * sizeof(T));
+}
+
+template <typename T> static void __readTable(std::ifstream& in, std::vector< std::vector<T> >& table, int rows, int cols){
+    int i;
+    table.resize(rows);
+    for(i=0; i<rows; i++){
+        table[i].resize(cols);
+        in.read(reinterpret_cast<char *>(&table[i][0]), cols * sizeof(T));
+    }
+}
+
+
+/****************************************************************************************************************************************************
+ *                                                                                                                                                  *
+ * save : public class method                                                                                                                       *
+ *                                                                                                                                                  *
+ * input -                                                                                                                                          *
+ * path     [required], string,                         Output file                                                                                 *
+ *                                                                                                                                                  *
+ *              This function writes the fitted model (parameters, random tables and bin occupancy of hash tables) to a binary file,                *
+ *              so that it can be scored against without refitting. Only sizes of occupied bins are stored, since score needs nothing else.         *
+ *              File is in native byte order. Fails (without writing) if model is not fitted.                                                       *
+ *                                                                                                                                                  *
+ * Returns -                                                                                                                                        *
+ * status :         bool,                   true on success.                                                                                        *
+ *                                                                                                                                                  *
+ ****************************************************************************************************************************************************/
+bool cppFiRE::save(const std::string& path){
+
+    uint32_t _n;
+    int i;
+    unsigned int j;
+
+    if(this->L <= 0 || this->counts.size() != (size_t)this->L)   //Not fitted
+        return false;
+
+    std::ofstream out(path.c_str(), std::ios::binary);
+    if(!out)
+        return false;
+
+    out.write(MODEL_MAGIC, sizeof(MODEL_MAGIC));
+    __write(out, MODEL_VERSION);
+    __write(out, this->L);
+    __write(out, this->M);
+    __write(out, this->H);
+    __write(out, this->seed);
+    __write(out, this->size_);
+    __write(out, this->dim);
+    __write(out, this->min_);
+    __write(out, this->max_);
+
+    __writeTable(out, this->dims);
+    __writeTable(out, this->thresholds);
+    __writeTable(out, this->weights);
+
+    for(i=0; i<this->L; i++){
+        _n = 0;
+        for(j=0; j<this->H; j++)
+            if(this->counts[i][j] > 0) _n++;
+        __write(out, _n);                                               //Number of occupied bins
+        for(j=0; j<this->H; j++){
+            if(this->counts[i][j] == 0) continue;
+            __write(out, j);                                            //Bin index
+            __write(out, this->counts[i][j]);                           //Bin occupancy
+        }
+    }
+
+    return out.good();
+}
+
+
+/****************************************************************************************************************************************************
+ *                                                                                                                                                  *
+ * load : public class method                                                                                                                       *
+ *                                                                                                                                                  *
+ * input -                                                                                                                                          *
+ * path     [required], string,                         Input file written by save                                                                  *
+ *                                                                                                                                                  *
+ *              This function restores a model written by save. Class parameters (L, M, H, seed) are overwritten by stored values.                  *
+ *              Only bin occupancy (counts) is stored, so bins (sample indices) is left empty. File is read in a temporary model, which replaces    *
+ *              this one only on success, so a failed load leaves the model untouched. pseudoCount and verbose are kept.                            *
+ *                                                                                                                                                  *
+ * Returns -                                                                                                                                        *
+ * status :         bool,                   true on success.                                                                                        *
+ *                                                                                                                                                  *
+ ****************************************************************************************************************************************************/
+bool cppFiRE::load(const std::string& path){
+
+    std::ifstream in(path.c_str(), std::ios::binary);
+    char _magic[sizeof(MODEL_MAGIC)];
+    uint32_t _version, _count, _n, k;
+    int i;
+    unsigned int j;
+    cppFiRE _model(0, 0, 0, 0, this->verbose);                         //Temporary model, swapped in on success
+
+    if(!in)
+        return false;
+
+    in.read(_magic, sizeof(_magic));
+    __read(in, _version);
+    if(!in || std::string(_magic, sizeof(_magic)) != std::string(MODEL_MAGIC, sizeof(MODEL_MAGIC)) || _version != MODEL_VERSION)
+        return false;
+
+    __read(in, _model.L);
+    __read(in, _model.M);
+    __read(in, _model.H);
+    __read(in, _model.seed);
+    __read(in, _model.size_);
+    __read(in, _model.dim);
+    __read(in, _model.min_);
+    __read(in, _model.max_);
+    if(!in || _model.L <= 0 || _model.M <= 0 || _model.H == 0 || _model.size_ <= 0 || _model.dim <= 0)
+        return false;
+
+    __readTable(in, _model.dims, _model.L, _model.M);
+    __readTable(in, _model.thresholds, _model.L, _model.M);
+    __readTable(in, _model.weights, _model.L, _model.M);
+    if(!in)
+        return false;
+
+    for(i=0; i<_model.L; i++)
+        for(j=0; j<(unsigned int)_model.M; j++)
+            if(_model.dims[i][j] >= (uint32_t)_model.dim)
+                return false;
+
+    _model.counts.assign(_model.L, std::vector< uint32_t >(_model.H, 0));
+    for(i=0; i<_model.L; i++){
+        __read(in, _count);
+        for(k=0; in && k<_count; k++){
+            __read(in, j);
+            __read(in, _n);
+            if(!in || j >= _model.H)
+                return false;
+            _model.counts[i][j] = _n;                                   //Restoring bin occupancy
+        }
+        if(!in)
+            return false;
+    }
+
+    this->L = _model.L;
+    this->M = _model.M;
+    this->H = _model.H;
+    this->seed = _model.seed;
+    this->size_ = _model.size_;
+    this->dim = _model.dim;
+    this->min_ = _model.min_;
+    this->max_ = _model.max_;
+    this->dims.swap(_model.dims);
+    this->thresholds.swap(_model.thresholds);
+    this->weights.swap(_model.weights);
+    this->counts.swap(_model.counts);
+    this->bins.clear();                                                 //Sample indices are not stored
+
+    return true;
+}
+
+
+/****************************************************************************************************************************************************
+ *                                                                                                                                                  *
+ * nFeatures : public class method                                                                                                                  *
+ *                                                                                                                                                  *
+ * Returns -                                                                                                                                        *
+ * dim :            int,                    Number of features in data used to fit (or load) the model.                                             *
+ *                                                                                                                                                  *
+ ****************************************************************************************************************************************************/
+int cppFiRE::nFeatures(){
+    return this->dim;
+}
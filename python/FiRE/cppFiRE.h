@@ -30,6 +30,7 @@
 //Include all header file here.
 #include <vector>
 #include <cstddef>
+#include <string>
 
 
 //All typedef declerations here
@@ -42,6 +43,7 @@ class cppFiRE{
     public: unsigned int H;                                                 //Number of bins
     public: unsigned int seed;                                              //Seed for random number generator
     public: int verbose;                                                    //Controls verbosity of program (0/1)
+    public: float pseudoCount;                                              //Pseudo-count added to bin occupancy while scoring (0 - unsmoothed)
     private: int size_;                                                     //Total number of samples in provided data
     private: int dim;                                                       //Total number of features in provided data
     private: float min_;                                                    //Minimum value in the whole data
@@ -52,6 +54,8 @@ class cppFiRE{
     public: std::vector< std::vector< uint32_t > > weights;                 //Containder for randomly generated M weights
                                                                             //corresponding to randomly generated M feature indexes for each estimator
     public: std::vector< std::vector< std::vector< uint32_t > > > bins;     //Containder for hash table for each estimator
+    public: std::vector< std::vector< uint32_t > > counts;                  //Container for bin occupancy of hash table for each estimator
+                                                                            //(bins is left empty for a model restored by load)
 
     //Class methods Private
     private: void __getTables();                                                     //Private method for generating random tables.
@@ -62,6 +66,9 @@ class cppFiRE{
     public: void fit(std::vector< std::vector<float> >& X);                             //Public method to fit data - This method call for random table
                                                                                         //generation and hash table generation
     public: std::vector<float> score(std::vector< std::vector<float> >& X);             //Public method to compute score
+    public: bool save(const std::string& path);                                         //Public method to write fitted model to a binary file
+    public: bool load(const std::string& path);                                         //Public method to read fitted model from a binary file
+    public: int nFeatures();                                                            //Public method to get number of features of fitted model
 };
 
 #endif
@@ -0,0 +1,819 @@
+/*
+ * Copyright (C) 2018 Aashi Jindal, Prashant Gupta, Jayadeva, Debarka Sengupta (aashi.jindal@ee.iitd.ac.in, prashant.gupta@ee.iitd.ac.in, jayadeva@ee.iitd.ac.in, debarka@iiitd.com). All Rights Reserved.
+ *
+ * This file is part of FiRE.
+ *
+ * FiRE is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * FiRE is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with FiRE.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ *
+ * This file contains a long running scoring service built around cppFiRE.
+ * Model is fitted (or loaded) once, then scoring requests are read from stdin or a unix socket.
+ * Concurrent requests are coalesced into batches before being handed to cppFiRE::score.
+ *
+ * Usage:
+ *      fireServe --fit <data> [--L 100] [--M 50] [--H 1017881] [--seed 5489] [--save <model>] [options]
+ *      fireServe --model <model> [options]
+ *
+ * Protocol (line framed, same for stdin and socket):
+ *      Request  : "<id> <n>" followed by n lines, each holding whitespace separated feature values of one sample.
+ *      Response : "<id> <n>" followed by n lines, each holding score of corresponding sample (printed with enough digits to
+ *                 read back the exact float returned by cppFiRE::score).
+ *                 "<id> ERROR <message>" if request could not be scored.
+ *      "STATS" request returns "STATS count=<n> window=<w> p50=<us> p90=<us> p99=<us> max=<us>", per-request latency in microseconds
+ *      over last w requests. Responses (including STATS and errors) of a connection follow order of its requests.
+ *
+ */
+
+//Include all header file here.
+#include "cppFiRE.h"                                    //Carries declaration of cppFiRE class
+#include <algorithm>                                    //Required for sort.
+#include <atomic>                                       //Required for connection thread bookkeeping.
+#include <cerrno>                                       //Required for errno.
+#include <cfloat>                                       //Required for FLT_MAX.
+#include <climits>                                      //Required for INT_MAX/UINT_MAX.
+#include <chrono>                                       //Required for latency measurement.
+#include <cmath>                                        //Required for ceil.
+#include <condition_variable>                           //Required for batching queue.
+#include <csignal>                                      //Required for signal handling.
+#include <cstdlib>                                      //Required for strtof/strtol.
+#include <cstring>                                      //Required for strerror.
+#include <deque>                                        //Required for batching queue.
+#include <fstream>                                      //Required for reading data file.
+#include <iostream>                                     //Required for logging.
+#include <limits>                                       //Required for max_digits10 of served scores.
+#include <memory>                                       //Required for shared_ptr.
+#include <mutex>                                        //Required for batching queue.
+#include <sstream>                                      //Required for parsing data file.
+#include <thread>                                       //Required for batching and connection threads.
+#include <poll.h>                                       //Required for accept timeout.
+#include <sys/socket.h>                                 //Required for unix socket.
+#include <sys/time.h>                                   //Required for socket send timeout.
+#include <sys/un.h>                                     //Required for unix socket.
+#include <unistd.h>                                     //Required for read/write/close.
+
+typedef std::chrono::steady_clock Clock;
+
+
+//Service options
+struct Options{
+    std::string fitPath;                                //Data file to fit model on
+    std::string modelPath;                              //Fitted model file to load
+    std::string savePath;                               //File to write fitted model to
+    std::string socketPath;                             //Unix socket path, stdin/stdout is used if empty
+    int L;                                              //Number of estimators
+    int M;                                              //Number of features to be sampled
+    unsigned int H;                                     //Number of bins
+    unsigned int seed;                                  //Seed for random number generator
+    int verbose;                                        //Controls verbosity (0/1)
+    float pseudoCount;                                  //Pseudo-count added to bin occupancy while scoring
+    size_t maxBatch;                                    //Maximum number of samples in a batch
+    long maxWait;                                       //Maximum time (us) a request waits for batch to fill
+    size_t maxRequest;                                  //Maximum number of samples in one request
+    size_t statsWindow;                                 //Number of latest requests latency percentiles are computed over
+
+    Options() : L(100), M(50), H(1017881), seed(5489u), verbose(0), pseudoCount(1), maxBatch(256), maxWait(1000),
+                maxRequest(100000), statsWindow(10000) {}
+};
+
+
+//Limits protecting service from misbehaving clients
+static const size_t MAX_OUTBOX = 64 << 20;              //Maximum unsent response bytes per connection, client is dropped beyond this
+static const int SEND_TIMEOUT = 10;                     //Seconds a socket write may block before client is dropped
+
+
+/****************************************************************************************************************************************************
+ *                                                                                                                                                  *
+ * Connection : One client (stdin/stdout or a socket connection)                                                                                    *
+ *                                                                                                                                                  *
+ *              Responses are appended to outbox by batching thread and written by connection's own writer thread, so that a client which stops     *
+ *              reading cannot stall scoring for others. A client whose outbox exceeds MAX_OUTBOX, or whose socket write fails (or blocks longer    *
+ *              than SEND_TIMEOUT), is dropped.                                                                                                     *
+ *                                                                                                                                                  *
+ ****************************************************************************************************************************************************/
+class Connection{
+    public: int in;                                                         //Descriptor requests are read from
+    public: int out;                                                        //Descriptor responses are written to
+    private: bool owned;                                                    //Socket owned by connection (shut down on failure, closed on destruction)
+    private: std::string outbox;                                            //Responses not yet written
+    private: bool closing;                                                  //Set once no more responses will be queued
+    private: bool failed;                                                   //Set once client is dropped
+    private: std::mutex lock;                                               //Guards outbox, closing and failed
+    private: std::condition_variable ready;                                 //Signalled on send, close and failure
+    private: std::thread writer;                                            //Writer thread
+
+    public: Connection(int in, int out, bool owned) : in(in), out(out), owned(owned), closing(false), failed(false) {}
+    public: ~Connection(){ if(this->owned) ::close(this->in); }
+
+    public: void start(){
+        this->writer = std::thread(&Connection::writeLoop, this);
+    }
+
+    //Queues response, never blocks on client
+    public: void send(const std::string& data){
+        std::lock_guard<std::mutex> guard(this->lock);
+        if(this->failed || this->closing) return;
+        if(this->outbox.size() + data.size() > MAX_OUTBOX){
+            this->fail();
+            return;
+        }
+        this->outbox += data;
+        this->ready.notify_one();
+    }
+
+    //Marks end of responses, writer exits once outbox is written
+    public: void close(){
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->closing = true;
+        this->ready.notify_one();
+    }
+
+    //Waits for writer thread (after close)
+    public: void wait(){
+        if(this->writer.joinable()) this->writer.join();
+    }
+
+    //Stops reading from socket client, used on service shutdown
+    public: void interrupt(){
+        if(this->owned) shutdown(this->in, SHUT_RD);
+    }
+
+    private: void fail(){                                                   //Called with lock held
+        this->failed = true;
+        this->outbox.clear();
+        if(this->owned) shutdown(this->in, SHUT_RDWR);                      //Reader sees end of input
+        this->ready.notify_one();
+    }
+
+    private: void writeLoop(){
+        std::string chunk;
+        size_t done;
+        ssize_t n;
+
+        while(true){
+            {
+                std::unique_lock<std::mutex> guard(this->lock);
+                while(this->outbox.empty() && !this->closing && !this->failed)
+                    this->ready.wait(guard);
+                if(this->failed || this->outbox.empty())
+                    return;
+                chunk.swap(this->outbox);
+            }
+
+            for(done=0; done<chunk.size(); done+=n){
+                n = write(this->out, chunk.data() + done, chunk.size() - done);
+                if(n < 0 && errno == EINTR){ n = 0; continue; }
+                if(n <= 0){                                                 //Client went away or stopped reading
+                    std::lock_guard<std::mutex> guard(this->lock);
+                    this->fail();
+                    return;
+                }
+            }
+            chunk.clear();
+        }
+    }
+};
+
+
+//Kind of entry in batching queue. All responses of a connection pass through queue, so they keep request order.
+enum RequestKind{
+    SCORE,                                              //Samples to be scored
+    STATS,                                              //Latency percentiles request
+    REPLY,                                              //Prepared response (e.g. error)
+    CLOSE                                               //End of connection input
+};
+
+
+//One entry waiting in batching queue
+struct Request{
+    RequestKind kind;                                   //Kind of entry
+    std::shared_ptr<Connection> conn;                   //Client to respond to
+    std::string id;                                     //Client supplied request id
+    std::vector< std::vector<float> > X;                //Samples to be scored
+    std::string reply;                                  //Response of REPLY entry
+    Clock::time_point arrival;                          //Time at which request was completely read
+
+    Request() : kind(SCORE) {}
+};
+
+
+/****************************************************************************************************************************************************
+ *                                                                                                                                                  *
+ * Server : Batching scoring service                                                                                                                *
+ *                                                                                                                                                  *
+ *              Readers push parsed requests through submit. A single batching thread waits until either maxBatch samples are queued or the         *
+ *              oldest request has waited maxWait microseconds, then scores all taken requests with one call to cppFiRE::score and queues each      *
+ *              request its own slice of scores. Latency of last statsWindow requests (arrival to response) is kept for percentile reporting.       *
+ *                                                                                                                                                  *
+ ****************************************************************************************************************************************************/
+class Server{
+    private: cppFiRE& model;                                                //Fitted model
+    private: Options& opts;                                                 //Service options
+    private: std::deque< Request > queue;                                   //Pending requests
+    private: size_t queued;                                                 //Number of samples in pending requests
+    private: bool stopping;                                                 //Set once no more requests are accepted
+    private: std::mutex lock;                                               //Guards queue, queued and stopping
+    private: std::condition_variable ready;                                 //Signalled on submit and stop
+    private: std::vector< double > latencies;                               //Ring buffer of last statsWindow request latencies (us)
+    private: size_t served;                                                 //Total number of scored requests
+
+    public: Server(cppFiRE& model, Options& opts) : model(model), opts(opts), queued(0), stopping(false), served(0) {
+        this->latencies.reserve(opts.statsWindow);
+    }
+
+    //Queues request (taking over its contents), returns false once server is stopping
+    public: bool submit(Request& req){
+        std::lock_guard<std::mutex> guard(this->lock);
+        if(this->stopping)
+            return false;
+        this->queued += req.X.size();
+        this->queue.push_back(std::move(req));
+        req = Request();
+        this->ready.notify_one();
+        return true;
+    }
+
+    public: void stop(){
+        std::lock_guard<std::mutex> guard(this->lock);
+        this->stopping = true;
+        this->ready.notify_one();
+    }
+
+    //Batching loop, returns once stopped and queue is drained
+    public: void run(){
+        std::vector< Request > batch;
+        std::vector< std::vector<float> > X;
+        std::vector< float > scores;
+        std::string failure;                                                //Set if scoring of current batch failed
+        size_t i, j, offset;
+
+        while(true){
+            batch.clear();
+            {
+                std::unique_lock<std::mutex> guard(this->lock);
+                while(this->queue.empty() && !this->stopping)
+                    this->ready.wait(guard);
+                if(this->queue.empty())
+                    return;
+
+                Clock::time_point deadline = this->queue.front().arrival + std::chrono::microseconds(this->opts.maxWait);
+                while(!this->stopping && this->queued > 0 && this->queued < this->opts.maxBatch && Clock::now() < deadline)
+                    this->ready.wait_until(guard, deadline);
+
+                offset = 0;                                                 //Take whole requests up to maxBatch samples (at least one)
+                while(!this->queue.empty() && (batch.empty() || offset + this->queue.front().X.size() <= this->opts.maxBatch)){
+                    offset += this->queue.front().X.size();
+                    this->queued -= this->queue.front().X.size();
+                    batch.push_back(std::move(this->queue.front()));
+                    this->queue.pop_front();
+                }
+            }
+
+            failure.clear();
+            try{
+                X.clear();
+                for(i=0; i<batch.size(); i++)
+                    for(j=0; j<batch[i].X.size(); j++){
+                        X.push_back(std::vector<float>());
+                        X.back().swap(batch[i].X[j]);
+                    }
+                if(!X.empty())
+                    scores = this->model.score(X);                          //One scoring call for whole batch
+            }
+            catch(std::exception& e){                                       //e.g. bad_alloc, fail this batch only
+                failure = e.what();
+                std::vector< std::vector<float> >().swap(X);
+                std::cerr << "Scoring batch of " << batch.size() << " requests failed: " << failure << std::endl;
+            }
+
+            if(this->opts.verbose > 0 && !X.empty())
+                std::cerr << "Scored batch of " << batch.size() << " requests, " << X.size() << " samples" << std::endl;
+
+            offset = 0;
+            for(i=0; i<batch.size(); i++){                                  //Responses in queue order
+                switch(batch[i].kind){
+                    case SCORE:{
+                        if(!failure.empty()){
+                            batch[i].conn->send(batch[i].id + " ERROR scoring failed: " + failure + "\n");
+                            break;
+                        }
+                        std::ostringstream out;
+                        out.precision(std::numeric_limits<float>::max_digits10);       //Scores round-trip exactly
+                        out << batch[i].id << " " << batch[i].X.size() << "\n";
+                        for(j=0; j<batch[i].X.size(); j++)
+                            out << scores[offset + j] << "\n";
+                        offset += batch[i].X.size();
+                        batch[i].conn->send(out.str());
+                        this->record(batch[i].arrival);
+                        break;
+                    }
+                    case STATS:
+                        batch[i].conn->send(this->stats() + "\n");
+                        break;
+                    case REPLY:
+                        batch[i].conn->send(batch[i].reply);
+                        break;
+                    case CLOSE:
+                        batch[i].conn->close();
+                        break;
+                }
+            }
+        }
+    }
+
+    private: void record(Clock::time_point arrival){                        //Called by batching thread only
+        double us = std::chrono::duration<double, std::micro>(Clock::now() - arrival).count();
+        if(this->latencies.size() < this->opts.statsWindow)
+            this->latencies.push_back(us);
+        else
+            this->latencies[this->served % this->opts.statsWindow] = us;
+        this->served++;
+    }
+
+    //Latency percentiles (nearest rank) over last statsWindow requests, called by batching thread only
+    public: std::string stats(){
+        std::vector< double > sorted(this->latencies);
+        std::sort(sorted.begin(), sorted.end());
+
+        std::ostringstream out;
+        out << "STATS count=" << this->served << " window=" << sorted.size();
+        if(!sorted.empty()){
+            const double p[] = {50, 90, 99};
+            const char* name[] = {"p50", "p90", "p99"};
+            for(int k=0; k<3; k++){
+                size_t rank = (size_t)std::ceil(p[k] / 100.0 * sorted.size());
+                out << " " << name[k] << "=" << (long)sorted[rank > 0 ? rank - 1 : 0];
+            }
+            out << " max=" << (long)sorted.back();
+        }
+        return out.str();
+    }
+};
+
+
+//Set by SIGINT/SIGTERM, ends input of every connection so that queued requests are answered before exit
+static volatile sig_atomic_t interrupted = 0;
+static void onSignal(int){ interrupted = 1; }
+
+
+//Buffered line reader over a descriptor, lines longer than maxLine set overflow and end input (as does interrupted)
+class LineReader{
+    private: int fd;
+    private: size_t maxLine;
+    private: std::string buffer;
+    private: size_t start;
+    public: bool overflow;
+
+    public: LineReader(int fd, size_t maxLine) : fd(fd), maxLine(maxLine), start(0), overflow(false) {}
+
+    public: bool next(std::string& line){
+        char chunk[65536];
+        size_t end;
+        ssize_t n;
+
+        if(this->overflow) return false;
+        while((end = this->buffer.find('\n', this->start)) == std::string::npos){
+            this->buffer.erase(0, this->start);
+            this->start = 0;
+            if(this->buffer.size() > this->maxLine){
+                this->overflow = true;
+                return false;
+            }
+            if(interrupted)
+                n = 0;                                          //Treated as end of input
+            else{
+                struct pollfd pending;
+                pending.fd = this->fd;
+                pending.events = POLLIN;
+                if(poll(&pending, 1, 200) == 0) continue;       //Wake up periodically to check for signal
+                n = read(this->fd, chunk, sizeof(chunk));
+                if(n < 0 && errno == EINTR) continue;
+            }
+            if(n <= 0){
+                if(this->buffer.empty()) return false;
+                line.swap(this->buffer);                        //Last line without trailing newline
+                this->buffer.clear();
+                return true;
+            }
+            this->buffer.append(chunk, n);
+        }
+        if(end - this->start > this->maxLine){
+            this->overflow = true;
+            return false;
+        }
+        line.assign(this->buffer, this->start, end - this->start);
+        this->start = end + 1;
+        if(!line.empty() && line[line.size() - 1] == '\r') line.erase(line.size() - 1);
+        return true;
+    }
+};
+
+
+//Parses whitespace separated floats of line into row, returns number of values read
+static size_t parseRow(const std::string& line, std::vector<float>& row){
+    const char* p = line.c_str();
+    char* end;
+    float value;
+
+    row.clear();
+    while(true){
+        value = std::strtof(p, &end);
+        if(end == p) break;
+        row.push_back(value);
+        p = end;
+    }
+    while(*p == ' ' || *p == '\t') p++;
+    return (*p == '\0') ? row.size() : 0;               //Trailing garbage invalidates the row
+}
+
+
+//Queues prepared response behind earlier requests of connection (sent directly if server is stopping)
+static void reply(Server& server, std::shared_ptr<Connection>& conn, const std::string& text){
+    Request req;
+    req.kind = REPLY;
+    req.conn = conn;
+    req.reply = text;
+    req.arrival = Clock::now();
+    if(!server.submit(req))
+        conn->send(text);
+}
+
+
+/****************************************************************************************************************************************************
+ *                                                                                                                                                  *
+ * readRequests : Reads requests of one client until end of input and submits them to server.                                                       *
+ *                                                                                                                                                  *
+ *              Request sample count is untrusted, requests above maxRequest samples are answered with ERROR, and their rows are skipped            *
+ *              without being stored so that framing of later requests is kept.                                                                     *
+ *                                                                                                                                                  *
+ ****************************************************************************************************************************************************/
+static void readRequests(Server& server, std::shared_ptr<Connection>& conn, Options& opts, int dim){
+    LineReader reader(conn->in, (size_t)dim * 64 + 4096);                   //Generous bound on text length of one sample
+    std::string line, count;
+    Request req;
+    long long n, i;
+    char* end;
+    bool valid, tooLarge;
+
+    while(reader.next(line)){
+        std::istringstream header(line);
+        if(!(header >> req.id)) continue;                                   //Skip blank lines
+
+        if(req.id == "STATS"){
+            req.kind = STATS;
+            req.conn = conn;
+            req.arrival = Clock::now();
+            if(!server.submit(req))
+                conn->send("STATS ERROR shutting down\n");
+            continue;
+        }
+
+        count.clear();
+        header >> count;
+        n = std::strtoll(count.c_str(), &end, 10);
+        if(count.empty() || *end != '\0' || n < 0){
+            reply(server, conn, req.id + " ERROR malformed header, expected '<id> <n>'\n");
+            continue;
+        }
+
+        tooLarge = (n > (long long)opts.maxRequest);
+        if(tooLarge){                                                       //Answered before its rows arrive
+            std::ostringstream msg;
+            msg << req.id << " ERROR request of " << n << " samples exceeds --max-request " << opts.maxRequest << "\n";
+            reply(server, conn, msg.str());
+        }
+        valid = !tooLarge;
+        req.X.clear();
+        for(i=0; i<n; i++){
+            if(!reader.next(line))
+                break;
+            if(!valid)
+                continue;                                                   //Keep consuming remaining rows of request
+            req.X.push_back(std::vector<float>());
+            if(parseRow(line, req.X.back()) != (size_t)dim)
+                valid = false;
+        }
+
+        if(i < n){
+            if(!tooLarge)
+                reply(server, conn, req.id + (reader.overflow ? " ERROR line too long\n" : " ERROR truncated request\n"));
+            break;
+        }
+        if(tooLarge)
+            continue;
+        if(!valid){
+            std::ostringstream msg;
+            msg << req.id << " ERROR expected " << dim << " features per sample\n";
+            reply(server, conn, msg.str());
+            continue;
+        }
+        if(n == 0){
+            reply(server, conn, req.id + " 0\n");
+            continue;
+        }
+
+        req.kind = SCORE;
+        req.conn = conn;
+        req.arrival = Clock::now();
+        if(!server.submit(req))
+            conn->send(req.id + " ERROR shutting down\n");
+    }
+
+    if(reader.overflow)
+        reply(server, conn, "ERROR line too long\n");
+}
+
+
+/****************************************************************************************************************************************************
+ *                                                                                                                                                  *
+ * serveConnection : Serves one client, returns once all its responses are written (or client is dropped).                                          *
+ *                                                                                                                                                  *
+ ****************************************************************************************************************************************************/
+static void serveConnection(Server& server, std::shared_ptr<Connection> conn, Options& opts, int dim){
+    Request req;
+
+    conn->start();
+    try{
+        readRequests(server, conn, opts, dim);
+    }
+    catch(std::exception& e){                                               //e.g. bad_alloc, must not take down service
+        reply(server, conn, std::string("ERROR ") + e.what() + "\n");
+    }
+
+    req.kind = CLOSE;                                                       //Writer exits after responses queued before this
+    req.conn = conn;
+    req.arrival = Clock::now();
+    if(!server.submit(req))
+        conn->close();
+    conn->wait();
+}
+
+
+//Connection thread of socket mode
+struct Session{
+    std::shared_ptr<Connection> conn;
+    std::shared_ptr< std::atomic<bool> > done;          //Set when thread is about to exit
+    std::thread thread;
+};
+
+
+//Reads samples x features whitespace separated matrix
+static bool readData(const std::string& path, std::vector< std::vector<float> >& X){
+    std::ifstream in(path.c_str());
+    std::string line;
+
+    if(!in) return false;
+    while(std::getline(in, line)){
+        X.push_back(std::vector<float>());
+        if(parseRow(line, X.back()) == 0){
+            X.pop_back();
+            if(line.find_first_not_of(" \t\r") != std::string::npos) return false;
+            continue;
+        }
+        if(X.back().size() != X[0].size()) return false;
+    }
+    return !X.empty();
+}
+
+
+//Upper bounds of numeric options
+static const long long MAX_BINS = 1LL << 30;            //--H
+static const long long MAX_SAMPLES = 1000000000LL;      //--max-batch, --max-request
+static const long long MAX_WAIT = 60000000LL;           //--max-wait (us)
+static const long long MAX_STATS_WINDOW = 10000000LL;   //--stats-window
+
+
+//Parses integer option value in [low, high], reports error on stderr otherwise
+static bool parseInteger(const std::string& option, const char* text, long long low, long long high, long long& value){
+    char* end;
+
+    errno = 0;
+    value = std::strtoll(text, &end, 10);
+    if(end == text || *end != '\0' || errno == ERANGE || value < low || value > high){
+        std::cerr << "Invalid value '" << text << "' for " << option << ", expected integer in [" << low << ", " << high << "]" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+
+static void getHelp(){
+    std::cerr <<
+        " fireServe ( --fit <data> [ --L <L> --M <M> --H <H> --seed <seed> --save <model> ] | --model <model> ) [ options ]\n"
+        "\n"
+        " --fit <data>         : Fit model on whitespace separated [samples x features] text file.\n"
+        " --L <L>              : Number of estimators (Default: 100).\n"
+        " --M <M>              : Number of features to be sampled (Default: 50).\n"
+        " --H <H>              : Number of bins (Default: 1017881).\n"
+        " --seed <seed>        : Seed for random number generator (Default: 5489).\n"
+        " --save <model>       : Write fitted model to file, so that later runs can use --model.\n"
+        " --model <model>      : Load model written by --save instead of fitting.\n"
+        " --pseudo-count <c>   : Pseudo-count added to bin occupancy, keeps scores of unseen samples finite, 0 for unsmoothed (Default: 1).\n"
+        " --socket <path>      : Serve requests on unix socket, instead of stdin/stdout.\n"
+        " --max-batch <n>      : Maximum number of samples scored in one batch (Default: 256).\n"
+        " --max-wait <us>      : Maximum time a request waits for batch to fill (Default: 1000).\n"
+        " --max-request <n>    : Maximum number of samples in one request, larger requests get ERROR (Default: 100000).\n"
+        " --stats-window <n>   : Number of latest requests latency percentiles are computed over (Default: 10000).\n"
+        " --verbose            : Display progress on stderr.\n"
+        " --help               : Display this help.\n";
+}
+
+
+int main(int argc, char** argv){
+
+    Options opts;
+    std::string arg;
+    const char* value;
+    char* end;
+    long long number;
+    double real;
+    int i;
+
+    for(i=1; i<argc; i++){
+        arg = argv[i];
+        if(arg == "--help"){ getHelp(); return 0; }
+        if(arg == "--verbose"){ opts.verbose = 1; continue; }
+        if(i + 1 >= argc){ std::cerr << "Missing value for " << arg << std::endl; getHelp(); return 1; }
+        value = argv[++i];
+
+        if(arg == "--fit") opts.fitPath = value;
+        else if(arg == "--model") opts.modelPath = value;
+        else if(arg == "--save") opts.savePath = value;
+        else if(arg == "--socket") opts.socketPath = value;
+        else if(arg == "--L"){ if(!parseInteger(arg, value, 1, INT_MAX, number)) return 1; opts.L = number; }
+        else if(arg == "--M"){ if(!parseInteger(arg, value, 1, INT_MAX, number)) return 1; opts.M = number; }
+        else if(arg == "--H"){ if(!parseInteger(arg, value, 1, MAX_BINS, number)) return 1; opts.H = number; }
+        else if(arg == "--seed"){ if(!parseInteger(arg, value, 0, UINT_MAX, number)) return 1; opts.seed = number; }
+        else if(arg == "--max-batch"){ if(!parseInteger(arg, value, 1, MAX_SAMPLES, number)) return 1; opts.maxBatch = number; }
+        else if(arg == "--max-wait"){ if(!parseInteger(arg, value, 0, MAX_WAIT, number)) return 1; opts.maxWait = number; }
+        else if(arg == "--max-request"){ if(!parseInteger(arg, value, 1, MAX_SAMPLES, number)) return 1; opts.maxRequest = number; }
+        else if(arg == "--stats-window"){ if(!parseInteger(arg, value, 1, MAX_STATS_WINDOW, number)) return 1; opts.statsWindow = number; }
+        else if(arg == "--pseudo-count"){
+            errno = 0;
+            real = std::strtod(value, &end);
+            if(end == value || *end != '\0' || errno == ERANGE || !(real >= 0) || real > FLT_MAX){
+                std::cerr << "Invalid value '" << value << "' for " << arg << ", expected non-negative number" << std::endl;
+                return 1;
+            }
+            opts.pseudoCount = real;
+        }
+        else { std::cerr << "Unknown option " << arg << std::endl; getHelp(); return 1; }
+    }
+
+    if(opts.fitPath.empty() == opts.modelPath.empty()){
+        std::cerr << "Exactly one of --fit and --model is required" << std::endl;
+        getHelp();
+        return 1;
+    }
+    if(!opts.savePath.empty() && opts.fitPath.empty()){
+        std::cerr << "--save requires --fit (a model loaded by --model is already saved)" << std::endl;
+        return 1;
+    }
+
+    cppFiRE model(opts.L, opts.M, opts.H, opts.seed, opts.verbose);
+    Clock::time_point t0 = Clock::now();
+
+    if(!opts.modelPath.empty()){
+        bool loaded = false;
+        try{
+            loaded = model.load(opts.modelPath);
+        }
+        catch(std::bad_alloc&){}                                            //Corrupt table sizes
+        if(!loaded){
+            std::cerr << "Could not load model from " << opts.modelPath << std::endl;
+            return 1;
+        }
+    }
+    else{
+        std::vector< std::vector<float> > X;
+        if(!readData(opts.fitPath, X)){
+            std::cerr << "Could not read [samples x features] data from " << opts.fitPath << std::endl;
+            return 1;
+        }
+        bool fitted = true;
+        std::streambuf* stdoutBuf = std::cout.rdbuf(std::cerr.rdbuf());    //cppFiRE reports progress on cout, which carries responses in stdin mode
+        try{
+            model.fit(X);
+        }
+        catch(std::bad_alloc&){                                             //L x H hash tables do not fit in memory
+            fitted = false;
+        }
+        std::cout.rdbuf(stdoutBuf);
+        if(!fitted){
+            std::cerr << "Not enough memory to fit model with L=" << opts.L << ", H=" << opts.H << std::endl;
+            return 1;
+        }
+        if(!opts.savePath.empty() && !model.save(opts.savePath)){
+            std::cerr << "Could not save model to " << opts.savePath << std::endl;
+            return 1;
+        }
+        std::vector< std::vector< std::vector< uint32_t > > >().swap(model.bins);     //Sample indices are not needed for scoring (counts are), free them
+    }
+
+    model.pseudoCount = opts.pseudoCount;
+
+    std::cerr << "Model ready (L=" << model.L << ", M=" << model.M << ", H=" << model.H << ", features=" << model.nFeatures()
+              << ") in " << std::chrono::duration<double>(Clock::now() - t0).count() << "s" << std::endl;
+
+    signal(SIGPIPE, SIG_IGN);                                               //Client disconnects are handled by write
+
+    struct sigaction action;                                                //Stop reading on signal, queued requests are still answered
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = onSignal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    Server server(model, opts);
+    std::thread batcher(&Server::run, &server);
+
+    if(opts.socketPath.empty()){
+        std::shared_ptr<Connection> conn(new Connection(STDIN_FILENO, STDOUT_FILENO, false));
+        serveConnection(server, conn, opts, model.nFeatures());
+    }
+    else{
+        struct sockaddr_un addr;
+        struct pollfd pending;
+        struct timeval timeout;
+        std::vector< Session > sessions;
+        size_t k;
+        int listener, client;
+
+        if(opts.socketPath.size() >= sizeof(addr.sun_path)){
+            std::cerr << "Socket path too long: " << opts.socketPath << std::endl;
+            server.stop(); batcher.join();
+            return 1;
+        }
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        std::strcpy(addr.sun_path, opts.socketPath.c_str());
+
+        listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(opts.socketPath.c_str());
+        if(listener < 0 || bind(listener, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listener, 64) < 0){
+            std::cerr << "Could not listen on " << opts.socketPath << ": " << std::strerror(errno) << std::endl;
+            server.stop(); batcher.join();
+            return 1;
+        }
+
+        timeout.tv_sec = SEND_TIMEOUT;
+        timeout.tv_usec = 0;
+
+        std::cerr << "Listening on " << opts.socketPath << std::endl;
+        while(!interrupted){
+            for(k=0; k<sessions.size(); ){                                  //Reap finished connection threads
+                if(*sessions[k].done){
+                    sessions[k].thread.join();
+                    sessions[k] = std::move(sessions.back());
+                    sessions.pop_back();
+                }
+                else k++;
+            }
+
+            pending.fd = listener;
+            pending.events = POLLIN;
+            if(poll(&pending, 1, 200) <= 0)                                 //Wake up periodically to check for signal
+                continue;
+            client = accept(listener, NULL, NULL);
+            if(client < 0) continue;
+            setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+            sessions.push_back(Session());
+            Session& session = sessions.back();
+            session.conn.reset(new Connection(client, client, true));
+            session.done.reset(new std::atomic<bool>(false));
+            std::shared_ptr< std::atomic<bool> > done = session.done;
+            std::shared_ptr<Connection> conn = session.conn;
+            session.thread = std::thread([&server, &opts, &model, conn, done](){
+                serveConnection(server, conn, opts, model.nFeatures());
+                *done = true;
+            });
+        }
+
+        close(listener);
+        unlink(opts.socketPath.c_str());
+
+        for(k=0; k<sessions.size(); k++)                                    //Stop reading clients, queued requests are still answered
+            sessions[k].conn->interrupt();
+        for(k=0; k<sessions.size(); k++)
+            sessions[k].thread.join();
+    }
+
+    server.stop();                                                          //Drain pending requests
+    batcher.join();
+    std::cerr << server.stats() << std::endl;
+
+    return 0;
+}